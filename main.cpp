@@ -1,15 +1,37 @@
 #include <string>
+#include <array>
+#include <utility>
 #include <string_view>
 #include <vector>
 #include <span>
 #include <print>
 #include <ranges>
-#include <cassert>
+#include <algorithm>
 #include <optional>
+#include <system_error>
+#include <cstdio>
+#include <cerrno>
+#include <atomic>
+#include <thread>
+#include <exception>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <format>
+
+#include <sys/inotify.h>
+#include <unistd.h>
 
 #include <magic_enum/magic_enum.hpp>
 
+#include "tru/scanner.hpp"
+#include "tru/mapped_file.hpp"
+#include "tru/semantic_tokens.hpp"
+
 using namespace std::literals;
+using tru::token;
+using tru::scanner;
+using tru::scan_error;
 
 
 constexpr auto example = R"str(const lang = "tru";
@@ -18,234 +40,14 @@ var num = 12345.6789;
 )str"sv;
 
 
-struct token {
-    enum struct types {
-        equal,
-        semicolon,
-        dot,
-        comma,
-        l_paren,
-        r_paren,
-        string_literal,
-        number_literal,
-        identifier,
-        kw_const,
-        kw_var,
-        eof
-    };
-
-    types type;
-    std::string_view lexeme;
-    size_t line;
-    size_t column;
-};
-
 namespace {
-    auto space_buf = [] {
+    constexpr auto space_buf = [] {
         auto buf = std::array<char, 1024>{};
         buf.fill(' ');
         return buf;
     }();
 }
 
-class scanner {
-    //size_t pos = 0;
-    size_t cur_line = 1;
-    size_t cur_column = 0;
-    std::string_view::const_pointer cursor = nullptr;
-    std::string_view::const_pointer line_begin = nullptr;
-
-    [[nodiscard]] char cur() const {
-        assert(!eof());
-        return *cursor;
-    }
-
-    [[nodiscard]] bool eof() const {
-        assert(cursor);
-        assert(cursor >= src.begin() && cursor <= src.end());
-        return cursor == src.end();
-    }
-
-    [[nodiscard]] size_t pos() const {
-        assert(!eof());
-        return cursor - src.begin();
-    }
-
-    bool move_pos() {
-        assert(!eof());
-        if (*cursor == '\n') {
-            ++cur_line;
-            cur_column = 0;
-            line_begin = nullptr;
-        } else {
-            ++cur_column;
-        }
-        ++cursor;
-        if (line_begin == nullptr) {
-            line_begin = cursor;
-        }
-        return !eof();
-    }
-
-    [[nodiscard]] std::optional<char> peek_next() const {
-        assert(!eof());
-        if (cursor + 1 == src.end()) {
-            return std::nullopt;
-        }
-        return *(cursor + 1);
-    }
-
-    [[noreturn]]
-    void failure(const char* message) {
-        static auto empty = std::array<char, 512>();
-        empty.fill(' ');
-
-        std::println(stderr, "Error at line {} column {}: {}", cur_line, cur_column, message);
-        auto eol = cursor;
-        while (eol != src.end() && *eol != '\n') {
-            ++eol;
-        }
-        std::println(stderr, "{}", src.substr(line_begin - src.begin(), eol - line_begin));
-        std::println(stderr, "{}^", std::string_view(empty.begin(), cur_column));
-        exit(1);
-    }
-
-    void emit(token::types t) {
-        tokens.emplace_back(t, src.substr(pos(), 1), cur_line, cur_column);
-    }
-
-    void emit(token::types t, std::string_view lexeme) {
-        auto diff = cursor - lexeme.begin();
-        tokens.emplace_back(t, lexeme, cur_line, cur_column - diff);
-    }
-
-private:
-    void scan_number() {
-        auto start = cursor;
-        do {
-            move_pos();
-        } while (!eof() && std::isdigit(cur()));
-
-        if (cur() == '.') {
-            move_pos();
-            while (std::isdigit(cur())) {
-                move_pos();
-            }
-        }
-        auto lexeme = std::string_view(start, cursor - start);
-        emit(token::types::number_literal, lexeme);
-    }
-
-    void scan_string() {
-        auto start = cursor;
-
-        do {
-            move_pos();
-        } while (!eof() && cur() != '"');
-
-        if (cur() == '"') {
-            move_pos();
-        } else {
-            failure("Unterminated string reached end of file");
-        }
-
-        auto lexeme = std::string_view(start, cursor - start);
-        emit(token::types::string_literal, lexeme);
-    }
-
-    void scan_identifier() {
-        auto start = cursor;
-
-        do {
-            move_pos();
-        } while (!eof() && std::isalnum(cur()));
-
-        auto lexeme = std::string_view(start, cursor - start);
-        if (lexeme == "var") {
-            emit(token::types::kw_var, lexeme);
-        } else if (lexeme == "const") {
-            emit(token::types::kw_const, lexeme);
-        } else {
-            emit(token::types::identifier, lexeme);
-        }
-    }
-
-public:
-    auto scan(std::string_view input) -> std::span<token> {
-        using ttype = token::types;
-
-        src = input;
-        cursor = src.data();
-        line_begin = src.data();
-
-        while (!eof()) {
-            switch (cur()) {
-                case '=':
-                    emit(ttype::equal);
-                    move_pos();
-                    break;
-                case ';':
-                    emit(ttype::semicolon);
-                    move_pos();
-                    break;
-                case '\"': {
-                    scan_string();
-                    break;
-                }
-                case '.':
-                    emit(ttype::dot);
-                    move_pos();
-                    break;
-                case ',':
-                    emit(ttype::comma);
-                    move_pos();
-                    break;
-                case '(':
-                    emit(ttype::l_paren);
-                    move_pos();
-                    break;
-                case ')':
-                    emit(ttype::r_paren);
-                    move_pos();
-                    break;
-                default: {
-                    if (isspace(cur())) {
-                        move_pos();
-                        break;
-                    } else if (std::isalpha(cur())) {
-                        scan_identifier();
-                    } else if (std::isdigit(cur())) {
-                        scan_number();
-                    }
-                    else {
-                        failure("Unhandled text sequence");
-                    }
-                }
-            }
-        }
-        tokens.emplace_back(token::types::eof, std::string_view(), cur_line, cur_column);
-
-        return tokens;
-    }
-
-private:
-    std::string_view src;
-    std::vector<token> tokens;
-};
-
-template<>
-struct std::formatter<token> {
-    // ReSharper disable once CppMemberFunctionMayBeStatic
-    // ReSharper disable once CppParameterMayBeConstPtrOrRef
-    constexpr auto parse(std::format_parse_context &ctx) { // NOLINT(*-convert-member-functions-to-static)
-        return ctx.begin();
-    }
-
-    auto format(const token &obj, auto &ctx) const {
-        return std::format_to(ctx.out(), "token{{{}:{}:{}:{}}}", obj.line, obj.column, magic_enum::enum_name(obj.type), obj.lexeme);
-    }
-};
-
 void print_tokens(std::span<token> result, bool compact = true) {
     std::println("Tokens:");
     auto last_line = -1uz;
@@ -282,7 +84,7 @@ void annotate(std::span<token> result, std::string_view source) {
         explicit annotated_line(size_t n, std::string_view l): line_no(n), line(l) {}
         std::size_t line_no;
         std::string_view line;
-        std::vector<token> tokens;
+        std::span<token> tokens;
     };
 
     namespace r = std::ranges;
@@ -293,20 +95,35 @@ void annotate(std::span<token> result, std::string_view source) {
                    })
                    | r::to<std::vector>();
 
-    for (auto& t: result) {
-        a_lines.at(t.line - 1).tokens.push_back(t);
+    // Tokens come out of the scanner ordered by line, so each line's tokens are a contiguous slice of `result`.
+    auto next = result.begin();
+    for (auto& al: a_lines) {
+        auto first = next;
+        while (next != result.end() && next->line == al.line_no) {
+            ++next;
+        }
+        al.tokens = std::span(first, next);
     }
 
     auto tmp_buf = std::string(space_buf.data(), space_buf.size());
 
     for (auto& al: a_lines) {
+        if (tmp_buf.size() <= al.line.size()) {
+            tmp_buf.resize(al.line.size() + 1, ' ');
+        }
         std::println("line {}: {}", al.line_no, al.line);
 
         for (auto idx = static_cast<ssize_t>(al.tokens.size()) - 1; idx >= 0; --idx) {
-            const auto target_tok = al.tokens.at(idx);
-            std::fill_n(tmp_buf.begin(), al.line.size(), ' ');
+            const auto& target_tok = al.tokens[idx];
+            // The marker row has room for one column past the end of the line, where the eof token sits.
+            if (target_tok.column > al.line.size()) {
+                continue;
+            }
+            std::fill_n(tmp_buf.begin(), al.line.size() + 1, ' ');
             for (auto i = 0; i < idx; ++i) {
-                tmp_buf[al.tokens.at(i).column] = '|';
+                if (al.tokens[i].column <= al.line.size()) {
+                    tmp_buf[al.tokens[i].column] = '|';
+                }
             }
             tmp_buf[target_tok.column] = '^';
             std::println("        {} {}", std::string_view(tmp_buf.data(), target_tok.column + 1), magic_enum::enum_name(target_tok.type));
@@ -314,11 +131,276 @@ void annotate(std::span<token> result, std::string_view source) {
     }
 }
 
-int main() {
+void print_semantic_tokens(std::span<const std::uint32_t> data) {
+    for (auto i = 0uz; i + 5 <= data.size(); i += 5) {
+        std::println("{} {} {} {} {}", data[i], data[i + 1], data[i + 2], data[i + 3], data[i + 4]);
+    }
+}
+
+void report(const scan_error& e) {
+    std::println(stderr, "Error at line {} column {}: {}", e.line, e.column, e.what());
+    std::println(stderr, "{}", e.source_line);
+    std::println(stderr, "{}^", std::string_view(space_buf.data(), std::min(e.column, space_buf.size())));
+}
 
-    auto s = scanner();
-    auto result = s.scan(example);
+void report(std::exception_ptr error) {
+    try {
+        std::rethrow_exception(error);
+    } catch (const std::system_error& e) {
+        std::println(stderr, "Error: {}", e.what());
+    } catch (const scan_error& e) {
+        report(e);
+    } catch (const std::exception& e) {
+        std::println(stderr, "Error: {}", e.what());
+    }
+}
 
-    annotate(result, example);
+std::string read_all(std::FILE* stream, std::string_view name) {
+    // Large fixed-size reads keep the syscall count low for piped input.
+    constexpr auto chunk_size = 1uz << 20;
+
+    auto content = std::string();
+    auto size = 0uz;
+    while (true) {
+        content.resize(size + chunk_size);
+        auto n = std::fread(content.data() + size, 1, chunk_size, stream);
+        size += n;
+        if (n < chunk_size) {
+            break;
+        }
+    }
+    content.resize(size);
+    if (std::ferror(stream)) {
+        throw std::system_error(errno, std::generic_category(), std::format("Cannot read {}", name));
+    }
+    return content;
+}
+
+// Copies the file into memory. Unlike a mapping, the copy cannot fault if the file is truncated mid-scan.
+std::string read_file(const std::filesystem::path& path) {
+    auto file = std::unique_ptr<std::FILE, decltype(&std::fclose)>(std::fopen(path.c_str(), "rb"), &std::fclose);
+    if (!file) {
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + path.string());
+    }
+    return read_all(file.get(), path.string());
+}
+
+struct file_job {
+    std::optional<tru::mapped_file> file;
+    scanner s;
+    std::span<token> tokens;
+    std::exception_ptr error;
+};
+
+// Files are independent until imports are resolved, so each one is mapped and scanned on whichever worker
+// claims it next.
+std::vector<file_job> scan_files(std::span<char*> paths) {
+    auto jobs = std::vector<file_job>(paths.size());
+    auto next = std::atomic<size_t>(0);
+
+    auto worker = [&] {
+        for (auto i = next++; i < jobs.size(); i = next++) {
+            auto& job = jobs[i];
+            try {
+                job.tokens = job.s.scan(job.file.emplace(paths[i]).view());
+            } catch (...) {
+                job.error = std::current_exception();
+            }
+        }
+    };
+
+    auto worker_count = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), paths.size());
+    {
+        auto workers = std::vector<std::jthread>();
+        for (auto i = 1uz; i < worker_count; ++i) {
+            workers.emplace_back(worker);
+        }
+        worker();
+    }
+    return jobs;
+}
+
+// Re-scans a .tru file in `dir` each time it is written or moved in, leaving the other files alone.
+// Files are read rather than mapped, since an editor may truncate them while they are being scanned.
+int watch(const char* dir) {
+    auto fd = inotify_init1(IN_CLOEXEC);
+    if (fd < 0) {
+        std::println(stderr, "Error: cannot watch {}: {}", dir, std::generic_category().message(errno));
+        return 1;
+    }
+    if (inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE_SELF) < 0) {
+        std::println(stderr, "Error: cannot watch {}: {}", dir, std::generic_category().message(errno));
+        close(fd);
+        return 1;
+    }
+
+    auto rescan = [](const std::filesystem::path& path) {
+        std::println("{}:", path.string());
+        try {
+            auto source = read_file(path);
+            auto s = scanner();
+            annotate(s.scan(source), source);
+        } catch (const std::system_error& e) {
+            std::println(stderr, "Error: {}", e.what());
+        } catch (const scan_error& e) {
+            report(e);
+        }
+    };
+
+    auto rescan_all = [&] {
+        auto ec = std::error_code();
+        auto it = std::filesystem::directory_iterator(dir, ec);
+        for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+            if (it->path().extension() != ".tru") {
+                continue;
+            }
+            auto entry_ec = std::error_code();
+            if (it->is_regular_file(entry_ec)) {
+                rescan(it->path());
+            } else if (entry_ec) {
+                std::println(stderr, "Error: cannot stat {}: {}", it->path().string(), entry_ec.message());
+            }
+        }
+        if (ec) {
+            std::println(stderr, "Error: cannot list {}: {}", dir, ec.message());
+        }
+    };
+
+    alignas(inotify_event) char buf[4096];
+    while (true) {
+        auto len = read(fd, buf, sizeof(buf));
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::println(stderr, "Error: cannot read events for {}: {}", dir, std::generic_category().message(errno));
+            close(fd);
+            return 1;
+        }
+
+        for (auto ptr = buf; ptr < buf + len; ptr += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(ptr)->len) {
+            const auto* event = reinterpret_cast<inotify_event*>(ptr);
+            if (event->mask & (IN_DELETE_SELF | IN_UNMOUNT | IN_IGNORED)) {
+                // The watch is gone, so no further events will arrive.
+                std::println(stderr, "Error: {} is no longer watched, it was removed or unmounted", dir);
+                close(fd);
+                return 1;
+            }
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Some changes were lost, so none of the files can be assumed current.
+                std::println(stderr, "Warning: events for {} were dropped, rescanning all files", dir);
+                rescan_all();
+                continue;
+            }
+            if (event->len == 0 || !std::string_view(event->name).ends_with(".tru")) {
+                continue;
+            }
+
+            rescan(std::filesystem::path(dir) / event->name);
+        }
+    }
+}
+
+// Operand count for each mode flag; anything else on the command line is a list of source files.
+constexpr auto modes = std::array<std::pair<std::string_view, size_t>, 5>{{
+    {"-e", 1},
+    {"-", 0},
+    {"--watch", 1},
+    {"--semantic-tokens", 1},
+    {"--semantic-tokens-delta", 2},
+}};
+
+void usage(std::string_view problem) {
+    std::println(stderr, "Error: {}", problem);
+    std::println(stderr, "Usage: truc [<file>...]");
+    std::println(stderr, "       truc -e <script>");
+    std::println(stderr, "       truc -");
+    std::println(stderr, "       truc --watch <dir>");
+    std::println(stderr, "       truc --semantic-tokens <file>");
+    std::println(stderr, "       truc --semantic-tokens-delta <old> <new>");
+}
+
+int main(int argc, char* argv[]) {
+    const auto args = std::span(argv, argc).subspan(1);
+
+    if (!args.empty() && args[0][0] == '-') {
+        auto mode = std::ranges::find(modes, std::string_view(args[0]), &std::pair<std::string_view, size_t>::first);
+        if (mode == modes.end()) {
+            usage(std::format("unknown option {}", args[0]));
+            return 2;
+        }
+        if (args.size() - 1 != mode->second) {
+            usage(std::format("{} takes {} argument(s), got {}", args[0], mode->second, args.size() - 1));
+            return 2;
+        }
+    }
+
+    try {
+        auto input = std::string();
+        auto source = std::string_view();
+        if (args.empty()) {
+            source = example;
+        } else if (args[0] == "--watch"sv) {
+            return watch(args[1]);
+        } else if (args[0] == "--semantic-tokens"sv) {
+            auto file = tru::mapped_file(args[1]);
+            auto s = scanner();
+            // The legend maps the fourth integer of each row to a type name, as a server advertises it.
+            std::print("legend:");
+            for (auto name: tru::semantic_type_legend) {
+                std::print(" {}", name);
+            }
+            std::println();
+            print_semantic_tokens(tru::encode_semantic_tokens(s.scan(file.view())));
+            return 0;
+        } else if (args[0] == "--semantic-tokens-delta"sv) {
+            // Prints the edit an LSP client would receive when the document changes from the first file to the second.
+            auto old_file = tru::mapped_file(args[1]);
+            auto new_file = tru::mapped_file(args[2]);
+            auto old_scanner = scanner();
+            auto new_scanner = scanner();
+            auto old_data = tru::encode_semantic_tokens(old_scanner.scan(old_file.view()));
+            auto new_data = tru::encode_semantic_tokens(new_scanner.scan(new_file.view()));
+
+            auto edit = tru::semantic_tokens_delta(old_data, new_data);
+            std::println("edit {} {}", edit.start, edit.delete_count);
+            print_semantic_tokens(edit.data);
+            return 0;
+        } else if (args[0] == "-e"sv) {
+            source = args[1];
+        } else if (args[0] == "-"sv) {
+            input = read_all(stdin, "standard input");
+            source = input;
+        } else {
+            auto jobs = scan_files(args);
+            auto failed = false;
+            for (auto i = 0uz; i < jobs.size(); ++i) {
+                auto& job = jobs[i];
+                if (job.error) {
+                    if (jobs.size() > 1) {
+                        std::println(stderr, "{}:", args[i]);
+                    }
+                    report(job.error);
+                    failed = true;
+                    continue;
+                }
+                if (jobs.size() > 1) {
+                    std::println("{}:", args[i]);
+                }
+                annotate(job.tokens, job.file->view());
+            }
+            return failed ? 1 : 0;
+        }
+
+        auto s = scanner();
+        auto result = s.scan(source);
+        annotate(result, source);
+    } catch (const std::system_error& e) {
+        std::println(stderr, "Error: {}", e.what());
+        return 1;
+    } catch (const scan_error& e) {
+        report(e);
+        return 1;
+    }
     return 0;
 }
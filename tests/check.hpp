@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <source_location>
+
+// Minimal assertion for the test executables; unlike assert() it stays active in release builds.
+inline void check(bool condition, std::source_location where = std::source_location::current()) {
+    if (!condition) {
+        std::fprintf(stderr, "%s:%u: check failed\n", where.file_name(), static_cast<unsigned>(where.line()));
+        std::exit(1);
+    }
+}
@@ -0,0 +1,81 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <unistd.h>
+
+#include "tru/mapped_file.hpp"
+
+#include "check.hpp"
+
+using namespace std::literals;
+
+namespace {
+    // Creates a file with the given content and removes it when the test is done.
+    struct temp_file {
+        explicit temp_file(std::string_view content)
+            : path(std::filesystem::temp_directory_path() / ("tru_mapped_file_test_" + std::to_string(getpid()) + "_" + std::to_string(counter++))) {
+            std::ofstream(path, std::ios::binary) << content;
+        }
+
+        ~temp_file() {
+            std::filesystem::remove(path);
+        }
+
+        static inline int counter = 0;
+        std::filesystem::path path;
+    };
+
+    void non_regular_file_is_rejected() {
+        try {
+            auto file = tru::mapped_file("/dev/null");
+            check(false);
+        } catch (const std::system_error& e) {
+            check(e.code() == std::errc::invalid_argument);
+        }
+    }
+
+    void empty_file_gives_empty_non_null_view() {
+        auto tmp = temp_file("");
+        auto file = tru::mapped_file(tmp.path);
+        check(file.view().empty());
+        check(file.view().data() != nullptr);
+        check(file.bytes().empty());
+    }
+
+    void mapping_views_file_content() {
+        auto tmp = temp_file("var a = 1;\n");
+        auto file = tru::mapped_file(tmp.path);
+        check(file.view() == "var a = 1;\n");
+        check(file.bytes().size() == file.view().size());
+    }
+
+    void moved_from_files_are_safe_to_destroy() {
+        auto empty = temp_file("");
+        auto full = temp_file("const x = 2;");
+
+        auto a = tru::mapped_file(empty.path);
+        auto b = std::move(a);
+        check(b.view().empty() && b.view().data() != nullptr);
+
+        auto c = tru::mapped_file(full.path);
+        auto d = std::move(c);
+        check(d.view() == "const x = 2;");
+
+        // Assigning over a real mapping releases it; assigning over the empty sentinel must not unmap anything.
+        d = std::move(b);
+        check(d.view().empty());
+        b = tru::mapped_file(full.path);
+        check(b.view() == "const x = 2;");
+    }
+}
+
+int main() {
+    non_regular_file_is_rejected();
+    empty_file_gives_empty_non_null_view();
+    mapping_views_file_content();
+    moved_from_files_are_safe_to_destroy();
+    return 0;
+}
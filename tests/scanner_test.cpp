@@ -0,0 +1,93 @@
+#include <span>
+#include <cstddef>
+
+#include "tru/scanner.hpp"
+
+#include "check.hpp"
+
+using namespace std::literals;
+using tru::token;
+
+namespace {
+    void multi_line_string_keeps_start_position() {
+        auto s = tru::scanner();
+        auto tokens = s.scan("  \"ab\ncd\" y"sv);
+
+        check(tokens.size() == 3);
+        check(tokens[0].type == token::types::string_literal);
+        check(tokens[0].lexeme == "\"ab\ncd\"");
+        check(tokens[0].line == 1);
+        check(tokens[0].column == 2);
+        check(tokens[1].type == token::types::identifier);
+        check(tokens[1].line == 2);
+        check(tokens[1].column == 4);
+    }
+
+    void stopped_scan_throws_scan_cancelled() {
+        auto source = std::stop_source();
+        source.request_stop();
+
+        auto s = tru::scanner();
+        try {
+            s.scan("var a;\nvar b;\n"sv, source.get_token());
+            check(false);
+        } catch (const tru::scan_cancelled& e) {
+            check(e.line == 1);
+        }
+    }
+
+    void cancellation_inside_string_reports_line_break_column() {
+        auto source = std::stop_source();
+        source.request_stop();
+
+        auto s = tru::scanner();
+        try {
+            s.scan("\"a\nb\""sv, source.get_token());
+            check(false);
+        } catch (const tru::scan_cancelled& e) {
+            check(e.line == 1);
+            check(e.column == 2);
+        }
+    }
+
+    void number_at_end_of_input() {
+        auto s = tru::scanner();
+        for (auto source: {"1"sv, "12."sv}) {
+            auto tokens = s.scan(source);
+            check(tokens.size() == 2);
+            check(tokens[0].type == token::types::number_literal);
+            check(tokens[0].lexeme == source);
+            check(tokens[1].type == token::types::eof);
+        }
+    }
+
+    void import_and_export_are_keywords() {
+        auto s = tru::scanner();
+        auto tokens = s.scan("import export importx exports"sv);
+
+        check(tokens.size() == 5);
+        check(tokens[0].type == token::types::kw_import);
+        check(tokens[1].type == token::types::kw_export);
+        check(tokens[2].type == token::types::identifier && tokens[2].lexeme == "importx");
+        check(tokens[3].type == token::types::identifier && tokens[3].lexeme == "exports");
+    }
+
+    void empty_buffers_scan_to_eof() {
+        auto s = tru::scanner();
+        auto from_view = s.scan(std::string_view());
+        check(from_view.size() == 1 && from_view[0].type == token::types::eof);
+
+        auto from_bytes = s.scan(std::span<const std::byte>());
+        check(from_bytes.size() == 1 && from_bytes[0].type == token::types::eof);
+    }
+}
+
+int main() {
+    multi_line_string_keeps_start_position();
+    stopped_scan_throws_scan_cancelled();
+    cancellation_inside_string_reports_line_break_column();
+    empty_buffers_scan_to_eof();
+    import_and_export_are_keywords();
+    number_at_end_of_input();
+    return 0;
+}
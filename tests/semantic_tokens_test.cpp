@@ -0,0 +1,54 @@
+#include <vector>
+#include <algorithm>
+
+#include "tru/scanner.hpp"
+#include "tru/semantic_tokens.hpp"
+
+#include "check.hpp"
+
+using namespace std::literals;
+
+namespace {
+    auto encode(std::string_view source) {
+        auto s = tru::scanner();
+        return tru::encode_semantic_tokens(s.scan(source));
+    }
+
+    void columns_and_lengths_are_utf16() {
+        // "é" is two UTF-8 bytes but one UTF-16 unit, "😀" is four bytes and a surrogate pair.
+        auto data = encode("a = \"\xC3\xA9\xF0\x9F\x98\x80\"; b"sv);
+
+        auto expected = std::vector<std::uint32_t>{
+            0, 0, 1, 3, 0,
+            0, 2, 1, 4, 0,
+            0, 2, 5, 1, 0,
+            0, 7, 1, 3, 0,
+        };
+        check(std::ranges::equal(data, expected));
+    }
+
+    void delta_covers_only_the_changed_tokens() {
+        auto before = encode("var a = 1;\nvar b = 2;\nvar c = 3;\n"sv);
+        auto after = encode("var a = 1;\nvar bb = x;\nvar c = 3;\n"sv);
+
+        auto edit = tru::semantic_tokens_delta(before, after);
+        // Everything up to the `var` on line 2 and from line 3 onwards encodes the same.
+        check(edit.start == 5 * 5);
+        check(edit.delete_count == 5 * 3);
+        auto expected = std::vector<std::uint32_t>{
+            0, 4, 2, 3, 0,
+            0, 3, 1, 4, 0,
+            0, 2, 1, 3, 0,
+        };
+        check(std::ranges::equal(edit.data, expected));
+
+        auto unchanged = tru::semantic_tokens_delta(before, before);
+        check(unchanged.delete_count == 0 && unchanged.data.empty());
+    }
+}
+
+int main() {
+    columns_and_lengths_are_utf16();
+    delta_covers_only_the_changed_tokens();
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "tru/mapped_file.hpp"
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tru {
+
+namespace {
+    // mmap rejects zero-length mappings; empty files still need a non-null view for the scanner.
+    constexpr auto empty_file = "";
+
+    [[noreturn]] void throw_errno(const std::filesystem::path& path, const char* what) {
+        throw std::system_error(errno, std::generic_category(), std::string(what) + " " + path.string());
+    }
+}
+
+mapped_file::mapped_file(const std::filesystem::path& path) {
+    auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw_errno(path, "Cannot open");
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) < 0) {
+        ::close(fd);
+        throw_errno(path, "Cannot stat");
+    }
+
+    // Pipes and character devices report a zero size and cannot be mapped; reading them is up to the caller.
+    if (!S_ISREG(st.st_mode)) {
+        ::close(fd);
+        throw std::system_error(std::make_error_code(std::errc::invalid_argument),
+                                "Cannot map non-regular file " + path.string());
+    }
+
+    size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        ::close(fd);
+        data = empty_file;
+        return;
+    }
+
+    auto addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        throw_errno(path, "Cannot map");
+    }
+    // The scanner makes a single forward pass.
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+    data = addr;
+}
+
+mapped_file::~mapped_file() {
+    unmap();
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+    : data(std::exchange(other.data, nullptr)), size(std::exchange(other.size, 0)) {}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        data = std::exchange(other.data, nullptr);
+        size = std::exchange(other.size, 0);
+    }
+    return *this;
+}
+
+void mapped_file::unmap() {
+    if (data != nullptr && data != empty_file) {
+        ::munmap(const_cast<void*>(data), size);
+    }
+    data = nullptr;
+    size = 0;
+}
+
+} // namespace tru
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string_view>
+#include <span>
+#include <cstddef>
+#include <filesystem>
+
+namespace tru {
+
+// Read-only memory mapping of a whole file. Tokens scanned from view() point straight into the mapping,
+// so the mapped_file must outlive them. Only regular files can be mapped; anything else throws std::system_error.
+class mapped_file {
+public:
+    explicit mapped_file(const std::filesystem::path& path);
+    ~mapped_file();
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+
+    [[nodiscard]] std::string_view view() const {
+        return {static_cast<const char*>(data), size};
+    }
+
+    [[nodiscard]] std::span<const std::byte> bytes() const {
+        return {static_cast<const std::byte*>(data), size};
+    }
+
+private:
+    void unmap();
+
+    const void* data = nullptr;
+    size_t size = 0;
+};
+
+} // namespace tru
@@ -0,0 +1,245 @@
+#include "tru/scanner.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+using namespace std::literals;
+
+namespace tru {
+
+namespace {
+    enum struct char_class : std::uint8_t {
+        other,
+        blank,
+        line_space,
+        digit,
+        alpha,
+    };
+
+    // One table load per byte instead of the locale-aware <cctype> calls, which are also undefined for
+    // negative chars.
+    constexpr auto char_classes = [] {
+        auto table = std::array<char_class, 256>{};
+        for (auto c: " \t\r"sv) {
+            table[static_cast<unsigned char>(c)] = char_class::blank;
+        }
+        for (auto c: "\n\v\f"sv) {
+            table[static_cast<unsigned char>(c)] = char_class::line_space;
+        }
+        for (auto c = '0'; c <= '9'; ++c) {
+            table[static_cast<unsigned char>(c)] = char_class::digit;
+        }
+        for (auto c = 'a'; c <= 'z'; ++c) {
+            table[static_cast<unsigned char>(c)] = char_class::alpha;
+            table[static_cast<unsigned char>(c - 'a' + 'A')] = char_class::alpha;
+        }
+        return table;
+    }();
+
+    char_class classify(char c) {
+        return char_classes[static_cast<unsigned char>(c)];
+    }
+
+    bool is_blank(char c) {
+        return classify(c) == char_class::blank;
+    }
+
+    bool is_space(char c) {
+        return is_blank(c) || classify(c) == char_class::line_space;
+    }
+
+    bool is_digit(char c) {
+        return classify(c) == char_class::digit;
+    }
+
+    bool is_alpha(char c) {
+        return classify(c) == char_class::alpha;
+    }
+
+    bool is_alnum(char c) {
+        return is_alpha(c) || is_digit(c);
+    }
+}
+
+bool scanner::move_pos() {
+    assert(!eof());
+    if (*cursor == '\n') {
+        // Line ends are the only polling point, so cancellation support costs one check per line.
+        if (stop.stop_requested()) {
+            throw scan_cancelled("Scan was cancelled", cur_line, cur_column, current_line());
+        }
+        ++cur_line;
+        cur_column = 0;
+        line_begin = nullptr;
+    } else {
+        ++cur_column;
+    }
+    ++cursor;
+    if (line_begin == nullptr) {
+        line_begin = cursor;
+    }
+    return !eof();
+}
+
+void scanner::skip_to(std::string_view::const_pointer target) {
+    assert(target >= cursor && target <= src.end());
+    while (auto nl = static_cast<const char*>(std::memchr(cursor, '\n', target - cursor))) {
+        // Keep the column current up to the line break, where move_pos() may report a cancellation.
+        cur_column += nl - cursor;
+        cursor = nl;
+        move_pos();
+    }
+    cur_column += target - cursor;
+    cursor = target;
+}
+
+std::optional<char> scanner::peek_next() const {
+    assert(!eof());
+    if (cursor + 1 == src.end()) {
+        return std::nullopt;
+    }
+    return *(cursor + 1);
+}
+
+std::string_view scanner::current_line() const {
+    auto eol = cursor;
+    while (eol != src.end() && *eol != '\n') {
+        ++eol;
+    }
+    return src.substr(line_begin - src.begin(), eol - line_begin);
+}
+
+void scanner::failure(const char* message) {
+    throw scan_error(message, cur_line, cur_column, current_line());
+}
+
+void scanner::emit(token::types t) {
+    tokens.emplace_back(t, src.substr(pos(), 1), cur_line, cur_column);
+}
+
+void scanner::emit(token::types t, std::string_view lexeme) {
+    auto diff = cursor - lexeme.begin();
+    tokens.emplace_back(t, lexeme, cur_line, cur_column - diff);
+}
+
+void scanner::emit(token::types t, std::string_view lexeme, size_t line, size_t column) {
+    tokens.emplace_back(t, lexeme, line, column);
+}
+
+void scanner::scan_number() {
+    auto start = cursor;
+    skip_run(is_digit);
+
+    if (!eof() && cur() == '.') {
+        move_pos();
+        skip_run(is_digit);
+    }
+    auto lexeme = std::string_view(start, cursor - start);
+    emit(token::types::number_literal, lexeme);
+}
+
+void scanner::scan_string() {
+    // A literal may span lines, so its position is taken at the opening quote rather than derived at the end.
+    auto start = cursor;
+    auto start_line = cur_line;
+    auto start_column = cur_column;
+
+    auto closing = static_cast<const char*>(std::memchr(cursor + 1, '"', src.end() - cursor - 1));
+    if (closing == nullptr) {
+        skip_to(src.end());
+        failure("Unterminated string reached end of file");
+    }
+    skip_to(closing + 1);
+
+    auto lexeme = std::string_view(start, cursor - start);
+    emit(token::types::string_literal, lexeme, start_line, start_column);
+}
+
+void scanner::scan_identifier() {
+    auto start = cursor;
+    skip_run(is_alnum);
+
+    auto lexeme = std::string_view(start, cursor - start);
+    if (lexeme == "var") {
+        emit(token::types::kw_var, lexeme);
+    } else if (lexeme == "const") {
+        emit(token::types::kw_const, lexeme);
+    } else if (lexeme == "import") {
+        emit(token::types::kw_import, lexeme);
+    } else if (lexeme == "export") {
+        emit(token::types::kw_export, lexeme);
+    } else {
+        emit(token::types::identifier, lexeme);
+    }
+}
+
+auto scanner::scan(std::string_view input, std::stop_token stop_token) -> std::span<token> {
+    using ttype = token::types;
+
+    // Empty host buffers often have a null data(); the cursor needs a real address even for no input.
+    src = input.data() != nullptr ? input : ""sv;
+    stop = std::move(stop_token);
+    cursor = src.data();
+    line_begin = src.data();
+    cur_line = 1;
+    cur_column = 0;
+    // A scanner may be reused for another buffer; drop views into the previous one.
+    tokens.clear();
+
+    while (!eof()) {
+        switch (cur()) {
+            case '=':
+                emit(ttype::equal);
+                move_pos();
+                break;
+            case ';':
+                emit(ttype::semicolon);
+                move_pos();
+                break;
+            case '\"': {
+                scan_string();
+                break;
+            }
+            case '.':
+                emit(ttype::dot);
+                move_pos();
+                break;
+            case ',':
+                emit(ttype::comma);
+                move_pos();
+                break;
+            case '(':
+                emit(ttype::l_paren);
+                move_pos();
+                break;
+            case ')':
+                emit(ttype::r_paren);
+                move_pos();
+                break;
+            case ' ':
+            case '\t':
+            case '\r':
+                skip_run(is_blank);
+                break;
+            default: {
+                if (is_space(cur())) {
+                    move_pos();
+                    break;
+                } else if (is_alpha(cur())) {
+                    scan_identifier();
+                } else if (is_digit(cur())) {
+                    scan_number();
+                }
+                else {
+                    failure("Unhandled text sequence");
+                }
+            }
+        }
+    }
+    tokens.emplace_back(token::types::eof, std::string_view(), cur_line, cur_column);
+
+    return tokens;
+}
+
+} // namespace tru
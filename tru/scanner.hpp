@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <cstddef>
+#include <cassert>
+#include <optional>
+#include <stdexcept>
+#include <stop_token>
+
+#include "tru/token.hpp"
+
+namespace tru {
+
+class scan_error : public std::runtime_error {
+public:
+    scan_error(const char* message, size_t line, size_t column, std::string_view source_line)
+        : std::runtime_error(message), line(line), column(column), source_line(source_line) {}
+
+    size_t line;
+    size_t column;
+    std::string source_line;
+};
+
+// Thrown instead of a plain scan_error when the scan is stopped through its stop token.
+class scan_cancelled : public scan_error {
+public:
+    using scan_error::scan_error;
+};
+
+class scanner {
+    size_t cur_line = 1;
+    size_t cur_column = 0;
+    std::string_view::const_pointer cursor = nullptr;
+    std::string_view::const_pointer line_begin = nullptr;
+
+    [[nodiscard]] char cur() const {
+        assert(!eof());
+        return *cursor;
+    }
+
+    [[nodiscard]] bool eof() const {
+        assert(cursor);
+        assert(cursor >= src.begin() && cursor <= src.end());
+        return cursor == src.end();
+    }
+
+    [[nodiscard]] size_t pos() const {
+        assert(!eof());
+        return cursor - src.begin();
+    }
+
+    bool move_pos();
+
+    // Advances over a run of characters that never includes a line break, updating the column once per run
+    // instead of once per character.
+    template<typename Pred>
+    void skip_run(Pred pred) {
+        auto start = cursor;
+        while (cursor != src.end() && pred(*cursor)) {
+            ++cursor;
+        }
+        cur_column += cursor - start;
+    }
+
+    // Advances to `target`, which may be several lines ahead, locating line breaks with memchr.
+    void skip_to(std::string_view::const_pointer target);
+
+    [[nodiscard]] std::optional<char> peek_next() const;
+    [[nodiscard]] std::string_view current_line() const;
+    [[noreturn]] void failure(const char* message);
+    void emit(token::types t);
+    void emit(token::types t, std::string_view lexeme);
+    void emit(token::types t, std::string_view lexeme, size_t line, size_t column);
+
+private:
+    void scan_number();
+    void scan_string();
+    void scan_identifier();
+
+public:
+    // Tokens reference `input` without copying it, so the caller keeps it alive as long as the tokens are used.
+    // Throws scan_error on malformed input and scan_cancelled when `stop_token` is triggered. The token is only
+    // checked at line breaks, so a scan over input without line breaks runs to completion.
+    auto scan(std::string_view input, std::stop_token stop_token = {}) -> std::span<token>;
+
+    // Same as above for host byte buffers, which are viewed as text in place.
+    auto scan(std::span<const std::byte> input, std::stop_token stop_token = {}) -> std::span<token> {
+        return scan(std::string_view(reinterpret_cast<const char*>(input.data()), input.size()), std::move(stop_token));
+    }
+
+private:
+    std::string_view src;
+    std::stop_token stop;
+    std::vector<token> tokens;
+};
+
+} // namespace tru
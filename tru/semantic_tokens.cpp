@@ -0,0 +1,105 @@
+#include "tru/semantic_tokens.hpp"
+
+#include <algorithm>
+#include <optional>
+
+namespace tru {
+
+namespace {
+    constexpr auto ints_per_token = 5uz;
+
+    // UTF-8 lead bytes start one UTF-16 unit each, except 4-byte sequences which need a surrogate pair.
+    // Continuation bytes add nothing.
+    size_t utf16_length(std::string_view text) {
+        auto length = 0uz;
+        for (auto c: text) {
+            auto byte = static_cast<unsigned char>(c);
+            if ((byte & 0xC0) != 0x80) {
+                length += byte >= 0xF0 ? 2 : 1;
+            }
+        }
+        return length;
+    }
+
+    std::optional<semantic_type> classify(token::types t) {
+        using ttype = token::types;
+        switch (t) {
+            case ttype::kw_const:
+            case ttype::kw_var:
+            case ttype::kw_import:
+            case ttype::kw_export:
+                return semantic_type::keyword;
+            case ttype::string_literal:
+                return semantic_type::string;
+            case ttype::number_literal:
+                return semantic_type::number;
+            case ttype::identifier:
+                return semantic_type::variable;
+            case ttype::equal:
+                return semantic_type::operator_;
+            default:
+                return std::nullopt;
+        }
+    }
+}
+
+auto encode_semantic_tokens(std::span<const token> tokens) -> std::vector<std::uint32_t> {
+    auto data = std::vector<std::uint32_t>();
+    data.reserve(tokens.size() * ints_per_token);
+
+    // LSP positions are zero-based, token lines are one-based.
+    auto prev_line = 0uz;
+    auto prev_column = 0uz;
+    for (const auto& t: tokens) {
+        auto type = classify(t.type);
+        if (!type || t.lexeme.contains('\n')) {
+            continue;
+        }
+
+        // Token columns are byte offsets from the start of the line, so the line prefix sits right before the lexeme.
+        auto line = t.line - 1;
+        auto column = utf16_length(std::string_view(t.lexeme.data() - t.column, t.column));
+        auto delta_line = line - prev_line;
+        auto delta_column = delta_line == 0 ? column - prev_column : column;
+        data.insert(data.end(), {
+            static_cast<std::uint32_t>(delta_line),
+            static_cast<std::uint32_t>(delta_column),
+            static_cast<std::uint32_t>(utf16_length(t.lexeme)),
+            static_cast<std::uint32_t>(*type),
+            0u,
+        });
+        prev_line = line;
+        prev_column = column;
+    }
+    return data;
+}
+
+auto semantic_tokens_delta(std::span<const std::uint32_t> previous, std::span<const std::uint32_t> current)
+    -> semantic_tokens_edit {
+    // Compare whole tokens so the edit never starts or ends in the middle of one.
+    auto max_common = std::min(previous.size(), current.size()) / ints_per_token;
+
+    auto prefix = 0uz;
+    while (prefix < max_common
+           && std::ranges::equal(previous.subspan(prefix * ints_per_token, ints_per_token),
+                                 current.subspan(prefix * ints_per_token, ints_per_token))) {
+        ++prefix;
+    }
+
+    auto suffix = 0uz;
+    while (suffix < max_common - prefix
+           && std::ranges::equal(previous.last((suffix + 1) * ints_per_token).first(ints_per_token),
+                                 current.last((suffix + 1) * ints_per_token).first(ints_per_token))) {
+        ++suffix;
+    }
+
+    auto start = prefix * ints_per_token;
+    auto tail = suffix * ints_per_token;
+    return {
+        static_cast<std::uint32_t>(start),
+        static_cast<std::uint32_t>(previous.size() - start - tail),
+        current.subspan(start, current.size() - start - tail),
+    };
+}
+
+} // namespace tru
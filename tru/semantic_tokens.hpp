@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <magic_enum/magic_enum.hpp>
+
+#include "tru/token.hpp"
+
+namespace tru {
+
+// LSP semantic token types, in the order the server legend lists them.
+enum struct semantic_type : std::uint32_t {
+    keyword,
+    string,
+    number,
+    variable,
+    operator_,
+};
+
+// Legend strings for the server capabilities, indexed by semantic_type. Spelled out rather than derived from the
+// enumerator names, which cannot be `operator`.
+constexpr auto semantic_type_legend = std::array<std::string_view, 5>{
+    "keyword",
+    "string",
+    "number",
+    "variable",
+    "operator",
+};
+static_assert(semantic_type_legend.size() == magic_enum::enum_count<semantic_type>());
+
+// Encodes tokens in the LSP relative format, five integers per token:
+// delta line, delta start column, length, type, modifiers.
+// Columns and lengths are in UTF-16 code units, the LSP default position encoding. `tokens` must still view the
+// scanned source, which is used to measure the text before each token on its line.
+// Punctuation and tokens spanning several lines are not classified and are left out.
+auto encode_semantic_tokens(std::span<const token> tokens) -> std::vector<std::uint32_t>;
+
+// A single edit replacing `delete_count` integers at `start` with `data`, as in an LSP SemanticTokensEdit.
+// `data` views the `current` array passed to semantic_tokens_delta(), which must outlive the edit.
+struct semantic_tokens_edit {
+    std::uint32_t start;
+    std::uint32_t delete_count;
+    std::span<const std::uint32_t> data;
+};
+
+// Smallest edit turning `previous` into `current`. Both are encodings from encode_semantic_tokens(), and
+// because the encoding is relative, an edit in the middle of a file leaves the rest of the array unchanged.
+auto semantic_tokens_delta(std::span<const std::uint32_t> previous, std::span<const std::uint32_t> current)
+    -> semantic_tokens_edit;
+
+} // namespace tru
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string_view>
+#include <format>
+
+#include <magic_enum/magic_enum.hpp>
+
+namespace tru {
+
+struct token {
+    enum struct types {
+        equal,
+        semicolon,
+        dot,
+        comma,
+        l_paren,
+        r_paren,
+        string_literal,
+        number_literal,
+        identifier,
+        kw_const,
+        kw_var,
+        kw_import,
+        kw_export,
+        eof
+    };
+
+    types type;
+    std::string_view lexeme;
+    size_t line;
+    size_t column;
+};
+
+} // namespace tru
+
+template<>
+struct std::formatter<tru::token> {
+    // ReSharper disable once CppMemberFunctionMayBeStatic
+    // ReSharper disable once CppParameterMayBeConstPtrOrRef
+    constexpr auto parse(std::format_parse_context &ctx) { // NOLINT(*-convert-member-functions-to-static)
+        return ctx.begin();
+    }
+
+    auto format(const tru::token &obj, auto &ctx) const {
+        return std::format_to(ctx.out(), "token{{{}:{}:{}:{}}}", obj.line, obj.column, magic_enum::enum_name(obj.type), obj.lexeme);
+    }
+};